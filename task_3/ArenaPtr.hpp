@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+// 32 bit pointers for structures built inside an arena, half the size of a normal pointer
+// ArenaPtr stores an offset from the start of the arena so needs the arena (or a snapshot of it) to dereference
+// RelPtr stores an offset from its own address so can be used like a normal pointer
+// Both stay valid if the whole arena is copied or mapped somewhere else
+
+template <typename T>
+class ArenaPtr
+{
+private:
+    // Offset 0 is a valid allocation so use the largest value for null
+    static constexpr uint32_t null_offset = UINT32_MAX;
+    uint32_t offset = null_offset;
+
+public:
+    ArenaPtr() = default;
+    explicit ArenaPtr(uint32_t offset) : offset(offset) {}
+
+    // Make an ArenaPtr from a normal pointer into the arena, null if it is too far from base to fit in 32 bits
+    static ArenaPtr fromPointer(const char *base, const T *ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return ArenaPtr();
+        }
+        uintptr_t distance = reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(base);
+        if (distance >= null_offset)
+        {
+            return ArenaPtr();
+        }
+        return ArenaPtr(static_cast<uint32_t>(distance));
+    }
+
+    T *get(char *base) const
+    {
+        return isNull() ? nullptr : reinterpret_cast<T *>(base + offset);
+    }
+    const T *get(const char *base) const
+    {
+        return isNull() ? nullptr : reinterpret_cast<const T *>(base + offset);
+    }
+
+    bool isNull() const
+    {
+        return offset == null_offset;
+    }
+    uint32_t getOffset() const
+    {
+        return offset;
+    }
+    bool operator==(const ArenaPtr &other) const
+    {
+        return offset == other.offset;
+    }
+    bool operator!=(const ArenaPtr &other) const
+    {
+        return offset != other.offset;
+    }
+};
+
+// Allocate in any arena with alloc<T> and getHeap, returns a null ArenaPtr if the allocation fails
+template <typename T, typename Arena>
+ArenaPtr<T> allocArenaPtr(Arena &arena, size_t N = 1)
+{
+    return ArenaPtr<T>::fromPointer(arena.getHeap(), arena.template alloc<T>(N));
+}
+
+template <typename T, typename Arena>
+T *deref(Arena &arena, ArenaPtr<T> ptr)
+{
+    return ptr.get(arena.getHeap());
+}
+
+template <typename T>
+class RelPtr
+{
+private:
+    // Offset 0 would point at itself, which is never a useful target, so use it for null
+    int32_t offset = 0;
+
+    void set(T *ptr)
+    {
+        if (ptr == nullptr)
+        {
+            offset = 0;
+            return;
+        }
+        intptr_t distance = reinterpret_cast<intptr_t>(ptr) - reinterpret_cast<intptr_t>(this);
+        // Targets outside of +/-2GB can't be stored, store null rather than a wrong address
+        offset = (distance > INT32_MAX || distance < INT32_MIN) ? 0 : static_cast<int32_t>(distance);
+    }
+
+public:
+    RelPtr() = default;
+    RelPtr(T *ptr)
+    {
+        set(ptr);
+    }
+    // Copying has to recalculate the offset as the copy is at a different address
+    RelPtr(const RelPtr &other)
+    {
+        set(other.get());
+    }
+    RelPtr &operator=(const RelPtr &other)
+    {
+        set(other.get());
+        return *this;
+    }
+    RelPtr &operator=(T *ptr)
+    {
+        set(ptr);
+        return *this;
+    }
+
+    T *get() const
+    {
+        if (offset == 0)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<T *>(reinterpret_cast<intptr_t>(this) + offset);
+    }
+    T *operator->() const
+    {
+        return get();
+    }
+    T &operator*() const
+    {
+        return *get();
+    }
+    explicit operator bool() const
+    {
+        return offset != 0;
+    }
+};
@@ -0,0 +1,249 @@
+#include "ArenaRedirect.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+// Replacement global operator new and delete for ScopedArenaRedirect
+// Anything not taken by an arena uses malloc/free, the same as the default operators
+
+thread_local RedirectTarget *current_redirect = nullptr;
+
+// Fixed size so operator delete can check it without allocating or taking a lock
+constexpr size_t max_redirect_ranges = 64;
+
+struct RedirectRange
+{
+    // begin is written last and cleared first so a non null begin always has a valid end
+    std::atomic<const char *> begin{nullptr};
+    std::atomic<const char *> end{nullptr};
+};
+
+static RedirectRange redirect_ranges[max_redirect_ranges];
+// Number of slots which have ever been used, lookups don't need to look further
+static std::atomic<size_t> redirect_range_count{0};
+static std::mutex redirect_ranges_lock;
+
+static bool isRegistered(const char *begin)
+{
+    size_t count = redirect_range_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (redirect_ranges[i].begin.load(std::memory_order_acquire) == begin)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool registerRedirectRange(const char *begin, const char *end)
+{
+    // Every scope registers its arena so usually it is already there
+    if (isRegistered(begin))
+    {
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(redirect_ranges_lock);
+    if (isRegistered(begin))
+    {
+        return true;
+    }
+    size_t count = redirect_range_count.load(std::memory_order_relaxed);
+    size_t slot = 0;
+    while (slot < count && redirect_ranges[slot].begin.load(std::memory_order_relaxed) != nullptr)
+    {
+        slot++;
+    }
+    if (slot == max_redirect_ranges)
+    {
+        return false;
+    }
+    redirect_ranges[slot].end.store(end, std::memory_order_relaxed);
+    redirect_ranges[slot].begin.store(begin, std::memory_order_release);
+    if (slot == count)
+    {
+        redirect_range_count.store(count + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+void unregisterRedirectRange(const char *begin)
+{
+    std::lock_guard<std::mutex> guard(redirect_ranges_lock);
+    size_t count = redirect_range_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (redirect_ranges[i].begin.load(std::memory_order_relaxed) == begin)
+        {
+            redirect_ranges[i].begin.store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+void *redirectAllocate(size_t bytes, size_t alignment)
+{
+    RedirectTarget *target = current_redirect;
+    if (target == nullptr || bytes > target->max_size)
+    {
+        return nullptr;
+    }
+    return target->allocate(target->arena, bytes, alignment);
+}
+
+bool redirectOwns(const void *ptr)
+{
+    const char *address = static_cast<const char *>(ptr);
+    size_t count = redirect_range_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const char *begin = redirect_ranges[i].begin.load(std::memory_order_acquire);
+        if (begin != nullptr && address >= begin && address < redirect_ranges[i].end.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fall back to the system allocator, calling the new handler until it succeeds like the default operator new
+static void *systemAllocate(size_t bytes, size_t alignment)
+{
+    if (bytes == 0)
+    {
+        bytes = 1;
+    }
+    while (true)
+    {
+        void *result = nullptr;
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            result = malloc(bytes);
+        }
+        else if (posix_memalign(&result, alignment, bytes) != 0)
+        {
+            result = nullptr;
+        }
+        if (result != nullptr)
+        {
+            return result;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            return nullptr;
+        }
+        handler();
+    }
+}
+
+static void *allocate(size_t bytes, size_t alignment)
+{
+    void *result = redirectAllocate(bytes, alignment);
+    if (result == nullptr)
+    {
+        result = systemAllocate(bytes, alignment);
+    }
+    return result;
+}
+
+static void *allocateOrThrow(size_t bytes, size_t alignment)
+{
+    void *result = allocate(bytes, alignment);
+    if (result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+// Arena memory is given back when the arena is reset so only free memory from the system allocator,
+// this includes objects which outlived their scope as the arena stays registered
+static void release(void *ptr)
+{
+    if (ptr != nullptr && !redirectOwns(ptr))
+    {
+        free(ptr);
+    }
+}
+
+void *operator new(size_t bytes)
+{
+    return allocateOrThrow(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new[](size_t bytes)
+{
+    return allocateOrThrow(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(size_t bytes, std::align_val_t alignment)
+{
+    return allocateOrThrow(bytes, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t bytes, std::align_val_t alignment)
+{
+    return allocateOrThrow(bytes, static_cast<size_t>(alignment));
+}
+void *operator new(size_t bytes, const std::nothrow_t &) noexcept
+{
+    return allocate(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new[](size_t bytes, const std::nothrow_t &) noexcept
+{
+    return allocate(bytes, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void *operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(bytes, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr) noexcept
+{
+    release(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept
+{
+    release(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    release(ptr);
+}
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept
+{
+    release(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    release(ptr);
+}
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    release(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    release(ptr);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include "BumpDown.hpp"
+// Sends global operator new to a BumpDown arena for the current thread while a ScopedArenaRedirect is alive
+// For code that calls new/delete directly and can't be given an allocator
+// Needs ArenaRedirect.cpp compiled into the program, it replaces the global operator new and delete
+//
+// {
+//     ScopedArenaRedirect redirect(arena);
+//     legacyParse(text); // new inside here comes from arena, delete of arena memory does nothing
+// }
+// arena.reset();
+// ...
+// unregisterArenaRedirect(arena); // before the arena is destroyed
+//
+// Outside of a scope, for requests bigger than the limit and when the arena is full the system allocator is used.
+// The first scope registers the arena's memory for the whole process, so objects which escape the scope can still
+// be deleted later, from any thread, until unregisterArenaRedirect is called for that arena.
+// Scopes can be nested but must end in the reverse order they were created. malloc is not redirected.
+
+struct RedirectTarget
+{
+    void *arena;
+    void *(*allocate)(void *arena, size_t bytes, size_t alignment);
+    size_t max_size;
+    RedirectTarget *previous;
+};
+
+// Innermost redirect for this thread, nullptr when there isn't one
+extern thread_local RedirectTarget *current_redirect;
+
+// Process wide list of arena memory which delete must not free, returns false if the list is full
+bool registerRedirectRange(const char *begin, const char *end);
+void unregisterRedirectRange(const char *begin);
+// Allocate from the current redirect, nullptr if there is none or it can't take the request
+void *redirectAllocate(size_t bytes, size_t alignment);
+// True if ptr is inside a registered arena
+bool redirectOwns(const void *ptr);
+
+class ScopedArenaRedirect
+{
+private:
+    RedirectTarget target;
+    bool active = false;
+
+    template <size_t Size>
+    static void *allocateFrom(void *arena, size_t bytes, size_t alignment)
+    {
+        return static_cast<BumpDown<Size> *>(arena)->allocBytes(bytes, alignment);
+    }
+
+public:
+    // Requests larger than max_size go to the system allocator, defaults to a quarter of the arena
+    // If the arena can't be registered nothing is redirected
+    template <size_t Size>
+    explicit ScopedArenaRedirect(BumpDown<Size> &arena, size_t max_size = Size / 4)
+    {
+        if (!registerRedirectRange(arena.getHeap(), arena.getHeap() + Size))
+        {
+            return;
+        }
+        target.arena = &arena;
+        target.allocate = &allocateFrom<Size>;
+        target.max_size = max_size;
+        target.previous = current_redirect;
+        current_redirect = &target;
+        active = true;
+    }
+    // Don't allow copying or assignment, the thread points at this object
+    ScopedArenaRedirect(const ScopedArenaRedirect &) = delete;
+    ScopedArenaRedirect &operator=(const ScopedArenaRedirect &) = delete;
+    ~ScopedArenaRedirect()
+    {
+        if (active)
+        {
+            current_redirect = target.previous;
+        }
+    }
+    bool isActive() const
+    {
+        return active;
+    }
+};
+
+// Call once nothing will delete memory from the arena any more, and before the arena is destroyed
+template <size_t Size>
+void unregisterArenaRedirect(BumpDown<Size> &arena)
+{
+    unregisterRedirectRange(arena.getHeap());
+}
@@ -1,10 +1,13 @@
+#pragma once
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
 // Size allocated to allocator
 template <size_t Size>
 class BumpDown{
     private:
     // 
-        char heap[Size];
+        alignas(std::max_align_t) char heap[Size];
         size_t next = Size;
         int alloc_count = 0;        
     public:
@@ -36,7 +39,28 @@ class BumpDown{
             
             alloc_count++;
             return result;
-            
+
+        }
+        // Untyped allocation for callers which only know the size and alignment e.g. operator new
+        // Size doesn't have to be a multiple of alignment so align after moving next down.
+        // Aligns the address rather than the offset as alignment can be bigger than the heap's own alignment
+        void* allocBytes(size_t bytes, size_t alignment){
+            // Zero byte requests still need their own address
+            if(bytes == 0){
+                bytes = 1;
+            }
+            if(bytes > next){
+                return nullptr;
+            }
+            uintptr_t address = reinterpret_cast<uintptr_t>(heap + next - bytes);
+            size_t padding = address % alignment;
+            if(padding > next - bytes){
+                return nullptr;
+            }
+            size_t aligned_next = next - bytes - padding;
+            next = aligned_next;
+            alloc_count++;
+            return heap + aligned_next;
         }
         void dealloc(){
             if(alloc_count > 0){
@@ -47,6 +71,11 @@ class BumpDown{
             }
             
         }
+        // Drop every allocation at once, used when the whole arena is recycled
+        void reset(){
+            next = Size;
+            alloc_count = 0;
+        }
         // Return next value for testing
         size_t getPtrPosition()const{
             return next;
@@ -56,4 +85,11 @@ class BumpDown{
         {
             return alloc_count;
         }
+        // Start of the heap, used to resolve offsets into the arena
+        const char* getHeap() const{
+            return heap;
+        }
+        char* getHeap(){
+            return heap;
+        }
 };
\ No newline at end of file
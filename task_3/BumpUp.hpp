@@ -1,10 +1,13 @@
+#pragma once
 #include <iostream>
+#include <cstddef>
 // Size allocated to allocator
 template <size_t Size>
 class BumpUp
 {
 private:
-    char heap[Size];
+    // Align the heap itself so offsets aligned inside it are also aligned in memory
+    alignas(std::max_align_t) char heap[Size];
     size_t next = 0;
     int alloc_count = 0;
 
@@ -47,6 +50,12 @@ public:
         }
         next = 0;
     }
+    // Drop every allocation at once, used when the whole arena is recycled
+    void reset()
+    {
+        next = 0;
+        alloc_count = 0;
+    }
 
     size_t getPtrPosition() const
     {
@@ -56,4 +65,13 @@ public:
     {
         return alloc_count;
     }
+    // Start of the heap, used to snapshot the used region and to resolve offsets
+    const char *getHeap() const
+    {
+        return heap;
+    }
+    char *getHeap()
+    {
+        return heap;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+// One arena split into a hot region and a cold region so frequently used objects stay packed together
+// Hot allocations bump up from the start of the heap and cold allocations bump down from the end,
+// so neither region needs a fixed size and the arena is full when they meet.
+// To allocate: arena.alloc<T, Hot>(N) or arena.alloc<T, Cold>(N), or just arena.alloc<T>(N) to use T's temperature
+
+// Temperature tags
+struct Hot
+{
+};
+struct Cold
+{
+};
+
+// Types can pick their region with a member "using temperature = Cold;", otherwise they are hot
+template <typename T, typename = void>
+struct arena_temperature
+{
+    using type = Hot;
+};
+template <typename T>
+struct arena_temperature<T, std::void_t<typename T::temperature>>
+{
+    using type = typename T::temperature;
+};
+
+// Usage of one region
+struct RegionStats
+{
+    size_t bytes_used;
+    int alloc_count;
+};
+
+// Size allocated to allocator
+template <size_t Size>
+class HotColdArena
+{
+private:
+    alignas(std::max_align_t) char heap[Size];
+    size_t hot_next = 0;
+    size_t cold_next = Size;
+    int hot_count = 0;
+    int cold_count = 0;
+
+    // Same as BumpUp::alloc but stops at the cold region instead of the end of the heap
+    void *allocHot(size_t required_size, size_t alignment)
+    {
+        size_t padding = (alignment - hot_next % alignment) % alignment;
+        size_t aligned_next = hot_next + padding;
+        if (aligned_next < hot_next || aligned_next > cold_next || required_size > cold_next - aligned_next)
+        {
+            return nullptr;
+        }
+        hot_next = aligned_next + required_size;
+        hot_count++;
+        return heap + aligned_next;
+    }
+
+    // Same as BumpDown::alloc but stops at the hot region instead of the start of the heap
+    void *allocCold(size_t required_size, size_t alignment)
+    {
+        size_t aligned_next = cold_next - cold_next % alignment;
+        if (aligned_next < hot_next || required_size > aligned_next - hot_next)
+        {
+            return nullptr;
+        }
+        cold_next = aligned_next - required_size;
+        cold_count++;
+        return heap + cold_next;
+    }
+
+    void *allocIn(Hot, size_t required_size, size_t alignment)
+    {
+        return allocHot(required_size, alignment);
+    }
+    void *allocIn(Cold, size_t required_size, size_t alignment)
+    {
+        return allocCold(required_size, alignment);
+    }
+
+public:
+    HotColdArena() = default;
+    // Don't allow assignment
+    HotColdArena &operator=(const HotColdArena &) = delete;
+
+    // Returns nullptr if the two regions would overlap
+    template <typename T, typename Temperature = typename arena_temperature<T>::type>
+    T *alloc(size_t N = 1)
+    {
+        static_assert(std::is_same<Temperature, Hot>::value || std::is_same<Temperature, Cold>::value,
+                      "Temperature must be Hot or Cold");
+        /* Use reinterpret cast as we are just treating the memory location as different type not doing type conversions.*/
+        return reinterpret_cast<T *>(allocIn(Temperature(), N * sizeof(T), alignof(T)));
+    }
+
+    // Drop every allocation in both regions
+    void reset()
+    {
+        hot_next = 0;
+        cold_next = Size;
+        hot_count = 0;
+        cold_count = 0;
+    }
+
+    RegionStats getStats(Hot) const
+    {
+        return {hot_next, hot_count};
+    }
+    RegionStats getStats(Cold) const
+    {
+        return {Size - cold_next, cold_count};
+    }
+    // Space left between the two regions
+    size_t getFreeSpace() const
+    {
+        return cold_next - hot_next;
+    }
+    const char *getHeap() const
+    {
+        return heap;
+    }
+    char *getHeap()
+    {
+        return heap;
+    }
+};
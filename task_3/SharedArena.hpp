@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "BumpUp.hpp"
+// Reference counted arenas for handing batches of objects from one thread to another
+// A producer takes an arena from an ArenaPool, allocates into it and hands out copies of the SharedArena handle
+// with each object. When the last copy is dropped the arena is reset and goes back to the pool.
+// Only one thread should allocate from an arena at a time, the reference count is the only thread safe part.
+
+template <size_t Size>
+class ArenaPool;
+
+template <size_t Size>
+class SharedArena
+{
+private:
+    friend class ArenaPool<Size>;
+
+    struct Slot
+    {
+        BumpUp<Size> arena;
+        // Keep the count on its own cache line so consumers don't fight with the producer writing to the arena
+        alignas(64) std::atomic<int> refs{0};
+        ArenaPool<Size> *pool = nullptr;
+    };
+    Slot *slot = nullptr;
+
+    explicit SharedArena(Slot *slot) : slot(slot)
+    {
+        slot->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        // Clear slot before giving the arena back in case this handle lives inside it
+        Slot *released = slot;
+        slot = nullptr;
+        // acq_rel so every write made by other owners is visible before the arena is reused
+        if (released != nullptr && released->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            released->arena.reset();
+            released->pool->giveBack(released);
+        }
+    }
+
+public:
+    SharedArena() = default;
+    SharedArena(const SharedArena &other) : slot(other.slot)
+    {
+        if (slot != nullptr)
+        {
+            slot->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    SharedArena(SharedArena &&other) noexcept : slot(other.slot)
+    {
+        other.slot = nullptr;
+    }
+    SharedArena &operator=(const SharedArena &other)
+    {
+        if (slot != other.slot)
+        {
+            SharedArena copy(other);
+            release();
+            slot = copy.slot;
+            copy.slot = nullptr;
+        }
+        return *this;
+    }
+    SharedArena &operator=(SharedArena &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            slot = other.slot;
+            other.slot = nullptr;
+        }
+        return *this;
+    }
+    ~SharedArena()
+    {
+        release();
+    }
+
+    // Returns nullptr if there is no arena or it is full
+    template <typename T>
+    T *alloc(size_t N = 1)
+    {
+        return slot ? slot->arena.template alloc<T>(N) : nullptr;
+    }
+    BumpUp<Size> *get() const
+    {
+        return slot ? &slot->arena : nullptr;
+    }
+    int useCount() const
+    {
+        return slot ? slot->refs.load(std::memory_order_relaxed) : 0;
+    }
+    explicit operator bool() const
+    {
+        return slot != nullptr;
+    }
+};
+
+// Fixed set of arenas which are handed out as SharedArena and come back when their last reference is dropped
+template <size_t Size>
+class ArenaPool
+{
+private:
+    friend class SharedArena<Size>;
+    using Slot = typename SharedArena<Size>::Slot;
+
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<Slot *> free_slots;
+    std::mutex lock;
+    std::condition_variable returned;
+
+    void giveBack(Slot *slot)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            free_slots.push_back(slot);
+        }
+        returned.notify_one();
+    }
+
+public:
+    explicit ArenaPool(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            slots.emplace_back(new Slot);
+            slots.back()->pool = this;
+            free_slots.push_back(slots.back().get());
+        }
+    }
+    // Don't allow copying or assignment, handles point back to the pool
+    ArenaPool(const ArenaPool &) = delete;
+    ArenaPool &operator=(const ArenaPool &) = delete;
+
+    // Waits until an arena is free
+    SharedArena<Size> acquire()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        returned.wait(guard, [this]()
+                      { return !free_slots.empty(); });
+        Slot *slot = free_slots.back();
+        free_slots.pop_back();
+        return SharedArena<Size>(slot);
+    }
+
+    // Returns an empty handle if every arena is in use
+    SharedArena<Size> tryAcquire()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (free_slots.empty())
+        {
+            return SharedArena<Size>();
+        }
+        Slot *slot = free_slots.back();
+        free_slots.pop_back();
+        return SharedArena<Size>(slot);
+    }
+
+    size_t available()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return free_slots.size();
+    }
+};
@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BumpUp.hpp"
+// Save the used region of a BumpUp arena to a file and mmap it back on the next start
+// File layout: header page, padding so the data keeps the original page offset, then the used bytes
+// To save: saveSnapshot(arena, "file.snap") and to load: MappedSnapshot snap; snap.open("file.snap")
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t alignment;   // alignment of the start of the data
+    uint64_t base;        // address of the heap when the snapshot was taken
+    uint64_t used;        // number of bytes used in the arena
+    uint64_t capacity;    // Size of the arena the snapshot was taken from
+    uint64_t data_offset; // where the data starts in the file
+    int64_t alloc_count;
+};
+
+constexpr char snapshot_magic[8] = {'B', 'U', 'M', 'P', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshot_version = 1;
+
+// Write everything until the buffer is done or there is an error
+inline bool writeAll(int fd, const char *buffer, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, buffer, length);
+        if (written <= 0)
+        {
+            return false;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return true;
+}
+
+// Returns false if the file could not be written
+template <size_t Size>
+bool saveSnapshot(const BumpUp<Size> &arena, const char *path)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t base = reinterpret_cast<uintptr_t>(arena.getHeap());
+
+    SnapshotHeader header{};
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.alignment = alignof(std::max_align_t);
+    header.base = base;
+    header.used = arena.getPtrPosition();
+    header.capacity = Size;
+    // Keep the data at the same offset within a page as the heap so it can be mapped back at the same address
+    header.data_offset = page_size + base % page_size;
+    header.alloc_count = arena.getAllocCount();
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header));
+    // Seek past the padding rather than writing zeros
+    ok = ok && lseek(fd, header.data_offset, SEEK_SET) == static_cast<off_t>(header.data_offset);
+    ok = ok && writeAll(fd, arena.getHeap(), header.used);
+    // Make sure the file covers the padding even when the arena is empty
+    ok = ok && ftruncate(fd, header.data_offset + header.used) == 0;
+    ok = (close(fd) == 0) && ok;
+    return ok;
+}
+
+// Read only view of a snapshot file mapped into memory
+class MappedSnapshot
+{
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    const char *data_start = nullptr;
+    SnapshotHeader header{};
+
+public:
+    MappedSnapshot() = default;
+    // Don't allow copying or assignment, the mapping is owned
+    MappedSnapshot(const MappedSnapshot &) = delete;
+    MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+    ~MappedSnapshot()
+    {
+        close();
+    }
+
+    // Map the file, first trying the address the arena had when it was saved so raw pointers stay valid.
+    // If that address is taken the file is mapped anywhere and only offsets can be used.
+    // Returns false if the file is missing or not a valid snapshot
+    bool open(const char *path, bool try_original_address = true)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat file_info;
+        if (fstat(fd, &file_info) != 0 || static_cast<size_t>(file_info.st_size) < sizeof(SnapshotHeader) ||
+            pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+            header.version != snapshot_version ||
+            // Alignment is used with % below so must be a power of two
+            header.alignment == 0 || (header.alignment & (header.alignment - 1)) != 0 ||
+            header.data_offset < sizeof(SnapshotHeader) ||
+            header.data_offset > static_cast<uint64_t>(file_info.st_size) ||
+            // Written this way round so it can't overflow
+            header.used > static_cast<uint64_t>(file_info.st_size) - header.data_offset)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        size_t length = file_info.st_size;
+        void *result = MAP_FAILED;
+        uintptr_t wanted = header.base - header.data_offset;
+        if (try_original_address && header.base >= header.data_offset && wanted % page_size == 0)
+        {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_FIXED_NOREPLACE
+            // Never clobber an existing mapping, fail instead
+            flags |= MAP_FIXED_NOREPLACE;
+#endif
+            result = mmap(reinterpret_cast<void *>(wanted), length, PROT_READ, flags, fd, 0);
+            // Older kernels treat the address as a hint so check where it landed
+            if (result != MAP_FAILED && reinterpret_cast<uintptr_t>(result) != wanted)
+            {
+                munmap(result, length);
+                result = MAP_FAILED;
+            }
+        }
+        if (result == MAP_FAILED)
+        {
+            result = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (result == MAP_FAILED)
+        {
+            return false;
+        }
+
+        mapping = result;
+        mapping_size = length;
+        data_start = static_cast<const char *>(result) + header.data_offset;
+        // Data must be at least as aligned as it was in the arena
+        if (reinterpret_cast<uintptr_t>(data_start) % header.alignment != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (mapping != nullptr)
+        {
+            munmap(mapping, mapping_size);
+        }
+        mapping = nullptr;
+        mapping_size = 0;
+        data_start = nullptr;
+    }
+
+    bool isOpen() const
+    {
+        return mapping != nullptr;
+    }
+    // True if the data is at the same address as the saved arena so raw pointers inside it are valid
+    bool atOriginalAddress() const
+    {
+        return isOpen() && reinterpret_cast<uintptr_t>(data_start) == header.base;
+    }
+    const char *data() const
+    {
+        return data_start;
+    }
+    size_t size() const
+    {
+        return header.used;
+    }
+    int getAllocCount() const
+    {
+        return static_cast<int>(header.alloc_count);
+    }
+
+    // Get an object by its offset from the start of the arena, nullptr if it is out of range
+    template <typename T>
+    const T *at(size_t offset, size_t N = 1) const
+    {
+        if (!isOpen() || offset > header.used || N * sizeof(T) > header.used - offset)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(data_start + offset);
+    }
+
+    // Convert a pointer taken from the original arena into the mapped copy
+    template <typename T>
+    const T *translate(const T *original) const
+    {
+        return at<T>(reinterpret_cast<uintptr_t>(original) - header.base);
+    }
+};
@@ -0,0 +1,182 @@
+#include "BumpUp.hpp"
+#include "ArenaPtr.hpp"
+#include "benchmark.hpp"
+#include <new>
+#include <random>
+#include <vector>
+using namespace std;
+
+// Builds the same binary search tree three times in a BumpUp arena, with normal pointers,
+// ArenaPtr offsets from the arena base and RelPtr offsets from the pointer itself,
+// then times lookups and a full traversal of each
+
+constexpr size_t arenaSize = 64 * 1024 * 1024;
+constexpr int numNodes = 1000000;
+constexpr int numLookups = 1000000;
+
+struct RawNode
+{
+    int key;
+    int value;
+    RawNode *left;
+    RawNode *right;
+};
+
+struct OffsetNode
+{
+    int key;
+    int value;
+    ArenaPtr<OffsetNode> left;
+    ArenaPtr<OffsetNode> right;
+};
+
+struct RelNode
+{
+    int key;
+    int value;
+    RelPtr<RelNode> left;
+    RelPtr<RelNode> right;
+};
+
+// Raw pointer tree
+void insert(BumpUp<arenaSize> &arena, RawNode *&root, int key)
+{
+    RawNode **slot = &root;
+    while (*slot != nullptr)
+    {
+        slot = key < (*slot)->key ? &(*slot)->left : &(*slot)->right;
+    }
+    *slot = new (arena.alloc<RawNode>()) RawNode{key, key * 2, nullptr, nullptr};
+}
+
+long long find(const RawNode *node, int key)
+{
+    while (node != nullptr && node->key != key)
+    {
+        node = key < node->key ? node->left : node->right;
+    }
+    return node ? node->value : 0;
+}
+
+long long sumTree(const RawNode *node)
+{
+    return node ? node->value + sumTree(node->left) + sumTree(node->right) : 0;
+}
+
+// ArenaPtr tree, the root is always the first allocation
+void insert(BumpUp<arenaSize> &arena, ArenaPtr<OffsetNode> &root, int key)
+{
+    ArenaPtr<OffsetNode> *slot = &root;
+    while (!slot->isNull())
+    {
+        OffsetNode *node = deref(arena, *slot);
+        slot = key < node->key ? &node->left : &node->right;
+    }
+    ArenaPtr<OffsetNode> added = allocArenaPtr<OffsetNode>(arena);
+    new (deref(arena, added)) OffsetNode{key, key * 2, {}, {}};
+    *slot = added;
+}
+
+long long find(const char *base, ArenaPtr<OffsetNode> ptr, int key)
+{
+    const OffsetNode *node = ptr.get(base);
+    while (node != nullptr && node->key != key)
+    {
+        node = (key < node->key ? node->left : node->right).get(base);
+    }
+    return node ? node->value : 0;
+}
+
+long long sumTree(const char *base, ArenaPtr<OffsetNode> ptr)
+{
+    const OffsetNode *node = ptr.get(base);
+    return node ? node->value + sumTree(base, node->left) + sumTree(base, node->right) : 0;
+}
+
+// RelPtr tree
+void insert(BumpUp<arenaSize> &arena, RelPtr<RelNode> &root, int key)
+{
+    RelPtr<RelNode> *slot = &root;
+    while (*slot)
+    {
+        slot = key < (*slot)->key ? &(*slot)->left : &(*slot)->right;
+    }
+    *slot = new (arena.alloc<RelNode>()) RelNode{key, key * 2, {}, {}};
+}
+
+long long find(const RelNode *node, int key)
+{
+    while (node != nullptr && node->key != key)
+    {
+        node = key < node->key ? node->left.get() : node->right.get();
+    }
+    return node ? node->value : 0;
+}
+
+long long sumTree(const RelNode *node)
+{
+    return node ? node->value + sumTree(node->left.get()) + sumTree(node->right.get()) : 0;
+}
+
+int main()
+{
+    // Same keys in the same order for every tree so the shapes match
+    mt19937 rng(42);
+    vector<int> keys(numNodes);
+    for (int &key : keys)
+    {
+        key = static_cast<int>(rng() % (numNodes * 4));
+    }
+    vector<int> lookups(numLookups);
+    for (int &key : lookups)
+    {
+        key = keys[rng() % numNodes];
+    }
+
+    cout << "Node sizes - raw: " << sizeof(RawNode) << " bytes, ArenaPtr: " << sizeof(OffsetNode)
+         << " bytes, RelPtr: " << sizeof(RelNode) << " bytes" << endl;
+
+    auto *rawArena = new BumpUp<arenaSize>;
+    auto *offsetArena = new BumpUp<arenaSize>;
+    auto *relArena = new BumpUp<arenaSize>;
+
+    RawNode *rawRoot = nullptr;
+    // Root pointers live outside the arena, RelPtr would need to be within 2GB so keep it in the arena too
+    ArenaPtr<OffsetNode> offsetRoot;
+    RelPtr<RelNode> *relRoot = new (relArena->alloc<RelPtr<RelNode>>()) RelPtr<RelNode>();
+    for (int key : keys)
+    {
+        insert(*rawArena, rawRoot, key);
+        insert(*offsetArena, offsetRoot, key);
+        insert(*relArena, *relRoot, key);
+    }
+    cout << "Arena used - raw: " << rawArena->getPtrPosition() << " bytes, ArenaPtr: " << offsetArena->getPtrPosition()
+         << " bytes, RelPtr: " << relArena->getPtrPosition() << " bytes" << endl;
+
+    long long rawResult = 0, offsetResult = 0, relResult = 0;
+    const char *offsetBase = offsetArena->getHeap();
+
+    report_time("raw pointer lookups", [&]()
+                { for (int key : lookups) rawResult += find(rawRoot, key); });
+    report_time("ArenaPtr lookups", [&]()
+                { for (int key : lookups) offsetResult += find(offsetBase, offsetRoot, key); });
+    report_time("RelPtr lookups", [&]()
+                { for (int key : lookups) relResult += find(relRoot->get(), key); });
+
+    report_time("raw pointer traversal", [&]()
+                { rawResult += sumTree(rawRoot); });
+    report_time("ArenaPtr traversal", [&]()
+                { offsetResult += sumTree(offsetBase, offsetRoot); });
+    report_time("RelPtr traversal", [&]()
+                { relResult += sumTree(relRoot->get()); });
+
+    // All trees hold the same data so the results have to match
+    cout << "Results match: " << ((rawResult == offsetResult && rawResult == relResult) ? "yes" : "no") << endl;
+
+    delete rawArena;
+    delete offsetArena;
+    delete relArena;
+    return 0;
+}
+
+// clang++ -std=c++17 -O2 arenaptr_benchmark.cpp
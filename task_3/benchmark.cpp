@@ -1,9 +1,14 @@
 #include "BumpUp.hpp"
 #include "BumpDown.hpp"
+#include "HotColdArena.hpp"
+#include "ArenaPtr.hpp"
+#include "SharedArena.hpp"
+#include "Snapshot.hpp"
 #include "benchmark.hpp"
 #include <simpletest.h>
 #include <chrono>
 #include <functional>
+#include <new>
 
 #include <tuple>
 #include <thread>
@@ -16,6 +21,20 @@ char const *groups[] = {
     "BumpDown",
 };
 
+// Number of alloc calls made by the tests in each group, in the same order as groups, used to report counters per allocation
+constexpr size_t allocsPerRun[] = {25, 25};
+static_assert(sizeof(allocsPerRun) / sizeof(allocsPerRun[0]) == sizeof(groups) / sizeof(groups[0]),
+              "allocsPerRun needs a count for every group");
+
+// Tests for features only one allocator has, run once after the timed groups so they don't skew the comparison
+char const *checkedGroups[] = {
+    "BumpDownAllocBytes",
+    "HotColdArena",
+    "ArenaPtr",
+    "SharedArena",
+    "Snapshot",
+};
+
 DEFINE_TEST_G(BasicAllocTest, BumpUp)
 {
     BumpUp<20 * sizeof(int)> bumper;
@@ -257,38 +276,324 @@ DEFINE_TEST_G(AlignmentAndPaddingTest, BumpDown){
 }
 
 
-int runTests(char const* group)
+DEFINE_TEST_G(AllocBytesAlignmentTest, BumpDownAllocBytes)
+{
+    // Alignments bigger than the heap's own alignment have to be done on the address
+    BumpDown<1024> allocator;
+
+    void *ptr64 = allocator.allocBytes(10, 64);
+    TEST_MESSAGE(ptr64 != nullptr, "Failed to allocate with 64 byte alignment");
+    TEST_MESSAGE(reinterpret_cast<uintptr_t>(ptr64) % 64 == 0, "Failed 64 byte alignment");
+
+    void *ptr128 = allocator.allocBytes(3, 128);
+    TEST_MESSAGE(ptr128 != nullptr, "Failed to allocate with 128 byte alignment");
+    TEST_MESSAGE(reinterpret_cast<uintptr_t>(ptr128) % 128 == 0, "Failed 128 byte alignment");
+
+    // Both must be inside the heap and not overlap
+    const char *heap = allocator.getHeap();
+    TEST_MESSAGE(static_cast<char *>(ptr128) >= heap && static_cast<char *>(ptr128) + 3 <= static_cast<char *>(ptr64), "Allocations overlap or are outside the heap");
+    TEST_MESSAGE(static_cast<char *>(ptr64) + 10 <= heap + 1024, "Allocation is outside the heap");
+}
+
+DEFINE_TEST_G(AllocBytesFitTest, BumpDownAllocBytes)
+{
+    // Exactly the size of the heap should fit and leave nothing
+    BumpDown<64> exact;
+    TEST_MESSAGE(exact.allocBytes(64, 1) != nullptr, "Failed to allocate the whole heap");
+    TEST_MESSAGE(exact.allocBytes(1, 1) == nullptr, "Should have failed to allocate from a full heap");
+
+    // One byte more than the heap should fail
+    BumpDown<64> over;
+    TEST_MESSAGE(over.allocBytes(65, 1) == nullptr, "Should have failed to allocate more than the heap");
+    TEST_MESSAGE(over.getPtrPosition() == 64, "Failed allocation moved the pointer");
+}
+
+DEFINE_TEST_G(AllocBytesZeroTest, BumpDownAllocBytes)
+{
+    // Zero byte allocations still have to return different addresses
+    BumpDown<64> allocator;
+    void *first = allocator.allocBytes(0, 1);
+    void *second = allocator.allocBytes(0, 1);
+    TEST_MESSAGE(first != nullptr && second != nullptr, "Failed to allocate zero bytes");
+    TEST_MESSAGE(first != second, "Zero byte allocations returned the same address");
+}
+
+
+DEFINE_TEST_G(RegionsMeetTest, HotColdArena)
+{
+    // Hot fills up from the start and cold down from the end until they meet exactly
+    HotColdArena<64> allocator;
+    int *hotPtr = allocator.alloc<int, Hot>(8);
+    int *coldPtr = allocator.alloc<int, Cold>(8);
+    TEST_MESSAGE(hotPtr != nullptr && coldPtr != nullptr, "Failed to allocate");
+    TEST_MESSAGE(hotPtr + 8 <= coldPtr, "Hot and cold regions overlap");
+    TEST_MESSAGE(allocator.getFreeSpace() == 0, "Regions should fill the whole heap");
+}
+
+DEFINE_TEST_G(RegionCollisionTest, HotColdArena)
+{
+    HotColdArena<64> allocator;
+    char *hotPtr = allocator.alloc<char, Hot>(40);
+    TEST_MESSAGE(hotPtr != nullptr, "Failed to allocate hot");
+    // Only 24 bytes left between the regions
+    char *tooBig = allocator.alloc<char, Cold>(32);
+    TEST_MESSAGE(tooBig == nullptr, "Cold should have failed to allocate into hot");
+    char *coldPtr = allocator.alloc<char, Cold>(24);
+    TEST_MESSAGE(coldPtr != nullptr, "Failed to allocate the rest as cold");
+    char *extraHot = allocator.alloc<char, Hot>();
+    TEST_MESSAGE(extraHot == nullptr, "Hot should have failed to allocate into cold");
+    char *extraCold = allocator.alloc<char, Cold>();
+    TEST_MESSAGE(extraCold == nullptr, "Cold should have failed to allocate into hot");
+    // Failed allocations don't change the regions
+    TEST_MESSAGE(allocator.getStats(Hot()).bytes_used == 40, "Hot region changed by failed allocation");
+    TEST_MESSAGE(allocator.getStats(Cold()).bytes_used == 24, "Cold region changed by failed allocation");
+}
+
+struct ColdRecord
+{
+    using temperature = Cold;
+    double value;
+};
+
+DEFINE_TEST_G(RegionStatsTest, HotColdArena)
+{
+    HotColdArena<1024> allocator;
+
+    // 3 chars then an int needs 1 byte of padding
+    allocator.alloc<char, Hot>(3);
+    allocator.alloc<int, Hot>();
+    RegionStats hot = allocator.getStats(Hot());
+    TEST_MESSAGE(hot.bytes_used == 8 && hot.alloc_count == 2, "Wrong hot region stats");
+
+    allocator.alloc<double, Cold>(2);
+    allocator.alloc<char, Cold>();
+    // Uses the type's temperature, 7 bytes of padding to align the double
+    allocator.alloc<ColdRecord>();
+    RegionStats cold = allocator.getStats(Cold());
+    TEST_MESSAGE(cold.bytes_used == 32 && cold.alloc_count == 3, "Wrong cold region stats");
+    TEST_MESSAGE(allocator.getStats(Hot()).bytes_used == 8, "Cold allocation changed hot region");
+    TEST_MESSAGE(allocator.getFreeSpace() == 1024 - 8 - 32, "Wrong free space");
+}
+
+
+DEFINE_TEST_G(ArenaPtrRoundTripTest, ArenaPtr)
+{
+    BumpUp<1024> allocator;
+    ArenaPtr<int> first = allocArenaPtr<int>(allocator);
+    ArenaPtr<int> second = allocArenaPtr<int>(allocator, 4);
+    TEST_MESSAGE(!first.isNull() && !second.isNull(), "Failed to allocate");
+    TEST_MESSAGE(first.getOffset() == 0 && second.getOffset() == sizeof(int), "Wrong offsets");
+    int *secondPtr = deref(allocator, second);
+    TEST_MESSAGE(secondPtr == reinterpret_cast<int *>(allocator.getHeap() + sizeof(int)), "Dereferenced to the wrong address");
+    TEST_MESSAGE(ArenaPtr<int>::fromPointer(allocator.getHeap(), secondPtr) == second, "fromPointer doesn't match the allocation");
+
+    // A failed allocation gives a null ArenaPtr
+    ArenaPtr<int> tooBig = allocArenaPtr<int>(allocator, 1024);
+    TEST_MESSAGE(tooBig.isNull(), "Failed allocation should be null");
+}
+
+DEFINE_TEST_G(ArenaPtrNullTest, ArenaPtr)
+{
+    BumpUp<64> allocator;
+    const char *base = allocator.getHeap();
+    ArenaPtr<int> empty;
+    TEST_MESSAGE(empty.isNull() && empty.get(base) == nullptr, "Default ArenaPtr should be null");
+    ArenaPtr<int> fromNull = ArenaPtr<int>::fromPointer(base, nullptr);
+    TEST_MESSAGE(fromNull.isNull() && fromNull == empty, "nullptr should give a null ArenaPtr");
+
+    // Pointers before the base or 4GB or more past it can't be stored
+    const int *before = reinterpret_cast<const int *>(base - sizeof(int));
+    TEST_MESSAGE(ArenaPtr<int>::fromPointer(base, before).isNull(), "Pointer before the base should be null");
+    const int *farAway = reinterpret_cast<const int *>(base + (uintptr_t(1) << 32));
+    TEST_MESSAGE(ArenaPtr<int>::fromPointer(base, farAway).isNull(), "Pointer out of 32 bit range should be null");
+}
+
+DEFINE_TEST_G(RelPtrCopyTest, ArenaPtr)
+{
+    BumpUp<1024> allocator;
+    int *target = allocator.alloc<int>();
+    RelPtr<int> *original = new (allocator.alloc<RelPtr<int>>()) RelPtr<int>(target);
+    TEST_MESSAGE(original->get() == target, "RelPtr doesn't point at its target");
+
+    // Copies are at a different address so have to store a different offset to reach the same target
+    RelPtr<int> *copied = new (allocator.alloc<RelPtr<int>>()) RelPtr<int>(*original);
+    TEST_MESSAGE(copied->get() == target, "Copy constructed RelPtr doesn't point at the target");
+    RelPtr<int> *assigned = new (allocator.alloc<RelPtr<int>>()) RelPtr<int>();
+    *assigned = *original;
+    TEST_MESSAGE(assigned->get() == target, "Assigned RelPtr doesn't point at the target");
+    RelPtr<int> onStack = *assigned;
+    TEST_MESSAGE(onStack.get() == target, "RelPtr copied out of the arena doesn't point at the target");
+}
+
+DEFINE_TEST_G(RelPtrNullTest, ArenaPtr)
+{
+    RelPtr<int> empty;
+    TEST_MESSAGE(!empty && empty.get() == nullptr, "Default RelPtr should be null");
+    int value = 1;
+    RelPtr<int> ptr(&value);
+    TEST_MESSAGE(ptr && *ptr == 1, "RelPtr doesn't point at its target");
+    ptr = nullptr;
+    TEST_MESSAGE(!ptr && ptr.get() == nullptr, "Assigning nullptr should make it null");
+    RelPtr<int> copied = ptr;
+    TEST_MESSAGE(!copied, "Copy of a null RelPtr should be null");
+}
+
+DEFINE_TEST_G(RelPtrOutOfRangeTest, ArenaPtr)
+{
+    // Never dereferenced, only used to check targets more than 2GB away are stored as null
+    RelPtr<int> ptr;
+    int *farAway = reinterpret_cast<int *>(reinterpret_cast<intptr_t>(&ptr) + (intptr_t(1) << 32));
+    ptr = farAway;
+    TEST_MESSAGE(!ptr && ptr.get() == nullptr, "Target out of 32 bit range should be null");
+    int *farBehind = reinterpret_cast<int *>(reinterpret_cast<intptr_t>(&ptr) - (intptr_t(1) << 32));
+    RelPtr<int> behind(farBehind);
+    TEST_MESSAGE(!behind, "Target out of 32 bit range should be null");
+}
+
+
+DEFINE_TEST_G(LastReleaseResetsTest, SharedArena)
+{
+    ArenaPool<1024> pool(2);
+    BumpUp<1024> *arena = nullptr;
+    {
+        SharedArena<1024> producer = pool.acquire();
+        TEST_MESSAGE(producer && pool.available() == 1, "Failed to acquire an arena");
+        arena = producer.get();
+        TEST_MESSAGE(producer.alloc<int>(10) != nullptr, "Failed to allocate");
+
+        SharedArena<1024> consumer = producer;
+        TEST_MESSAGE(consumer.get() == arena && consumer.useCount() == 2, "Copy should share the arena");
+        producer = SharedArena<1024>();
+        // Still referenced by the copy so it isn't reset or returned yet
+        TEST_MESSAGE(consumer.useCount() == 1 && pool.available() == 1, "Arena returned while still referenced");
+        TEST_MESSAGE(arena->getPtrPosition() == 10 * sizeof(int), "Arena reset while still referenced");
+    }
+    TEST_MESSAGE(pool.available() == 2, "Arena not returned to the pool after the last handle was dropped");
+    TEST_MESSAGE(arena->getPtrPosition() == 0 && arena->getAllocCount() == 0, "Arena not reset after the last handle was dropped");
+}
+
+DEFINE_TEST_G(PoolExhaustedTest, SharedArena)
+{
+    ArenaPool<64> pool(1);
+    SharedArena<64> held = pool.tryAcquire();
+    TEST_MESSAGE(held, "Failed to acquire an arena");
+    SharedArena<64> none = pool.tryAcquire();
+    TEST_MESSAGE(!none && none.alloc<int>() == nullptr, "Should have failed to acquire from an empty pool");
+    held = SharedArena<64>();
+    SharedArena<64> again = pool.tryAcquire();
+    TEST_MESSAGE(again, "Failed to acquire the returned arena");
+}
+
+const char *testSnapshotPath = "test_arena.snap";
+
+DEFINE_TEST_G(SnapshotRoundTripTest, Snapshot)
+{
+    BumpUp<1024> arena;
+    int *values = arena.alloc<int>(10);
+    for (int i = 0; i < 10; ++i)
+    {
+        values[i] = i * 3;
+    }
+    arena.alloc<char>(5);
+    TEST_MESSAGE(saveSnapshot(arena, testSnapshotPath), "Failed to write snapshot");
+
+    MappedSnapshot snapshot;
+    TEST_MESSAGE(snapshot.open(testSnapshotPath), "Failed to map snapshot");
+    TEST_MESSAGE(snapshot.size() == arena.getPtrPosition() && snapshot.getAllocCount() == 2, "Snapshot header doesn't match the arena");
+    const int *mapped = snapshot.at<int>(0, 10);
+    TEST_MESSAGE(mapped != nullptr && mapped[9] == 27, "Mapped data doesn't match the arena");
+    TEST_MESSAGE(snapshot.translate(values + 4) != nullptr && *snapshot.translate(values + 4) == 12, "Failed to translate a pointer into the snapshot");
+    // Reads past the used bytes are refused
+    TEST_MESSAGE(snapshot.at<int>(0, 20) == nullptr, "Read past the end of the snapshot should fail");
+    snapshot.close();
+    remove(testSnapshotPath);
+}
+
+// Overwrites the header of the test snapshot then tries to open it
+bool openWithHeader(const SnapshotHeader &header)
+{
+    int fd = open(testSnapshotPath, O_WRONLY);
+    bool written = fd >= 0 && pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    MappedSnapshot snapshot;
+    return written && snapshot.open(testSnapshotPath);
+}
+
+DEFINE_TEST_G(SnapshotCorruptHeaderTest, Snapshot)
+{
+    BumpUp<1024> arena;
+    arena.alloc<double>(8);
+    TEST_MESSAGE(saveSnapshot(arena, testSnapshotPath), "Failed to write snapshot");
+    SnapshotHeader header{};
+    int fd = open(testSnapshotPath, O_RDONLY);
+    TEST_MESSAGE(fd >= 0 && pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)), "Failed to read snapshot header");
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    TEST_MESSAGE(openWithHeader(header), "Failed to map unchanged snapshot");
+
+    SnapshotHeader corrupt = header;
+    corrupt.alignment = 3;
+    TEST_MESSAGE(!openWithHeader(corrupt), "Alignment that isn't a power of two should fail");
+    corrupt = header;
+    corrupt.alignment = 0;
+    TEST_MESSAGE(!openWithHeader(corrupt), "Zero alignment should fail");
+    corrupt = header;
+    corrupt.data_offset = 0;
+    TEST_MESSAGE(!openWithHeader(corrupt), "Data offset inside the header should fail");
+    corrupt = header;
+    corrupt.data_offset = UINT64_MAX;
+    TEST_MESSAGE(!openWithHeader(corrupt), "Data offset past the end of the file should fail");
+    corrupt = header;
+    corrupt.used = UINT64_MAX;
+    TEST_MESSAGE(!openWithHeader(corrupt), "Used bytes past the end of the file should fail");
+    remove(testSnapshotPath);
+}
+
+int runTests(char const* group, TestFixture::OutputMode output)
 // The execution of this function is calculated
 {
     bool pass = true;
     
-    pass &= TestFixture::ExecuteTestGroup(group, TestFixture::Verbose);
+    pass &= TestFixture::ExecuteTestGroup(group, output);
     
     return pass ? 0 : 1;
 }
 
 int main()
 {
-    for (auto group : groups){
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); ++g){
+        auto group = groups[g];
         // Timing mutiple runs for each group and then take average
         double totalTime = 0.0;
         int numRuns = 5;
         cout << "Running tests for group "<< group << endl;
         for(int i =0; i < numRuns; ++i){
             // report time and the benchmark function it calls is a variadric template so I can pass any number of argfs
-           auto execution_time = report_time("runTests", runTests, group);
+           auto execution_time = report_time("runTests", runTests, group, TestFixture::Verbose);
            totalTime+=execution_time;
            cout << "Run " << (i+1) << ": " << execution_time << " nanoseconds" << endl;
         }
         // Output average execution time for each allocator over number of runs
         double averageTime = totalTime / numRuns;
         cout << "Average time for " << group << ": " << averageTime << endl;
+        // One more run with hardware counters to see where the time goes, falls back to just time if they can't be read
+        // Silent so the counters measure the allocators rather than printing the test results
+        report_counters("runTests", allocsPerRun[g], runTests, group, TestFixture::Silent);
         
     }   
     
-    
+    bool pass = true;
+    for (auto group : checkedGroups){
+        cout << "Running tests for group " << group << endl;
+        pass &= TestFixture::ExecuteTestGroup(group, TestFixture::Verbose);
+    }
 
-    return 0;
+    return pass ? 0 : 1;
 }
 
 // clang++ -std=c++17 -O2 -I../simpletest_test/simpletest/ benchmark.cpp ../simpletest_test/simpletest/simpletest.cpp
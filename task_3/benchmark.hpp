@@ -1,8 +1,19 @@
+#pragma once
 #include <iostream>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 // Simple benchmark library to time the execution of a function
 // To get time: executionTime = report_time(functionName (str), function, arguments e.g group)
 // Can also just use benchmark but report time will output time to cl
+// To also get hardware counters: report_counters(functionName (str), numAllocations, function, arguments)
+// or report_counters(functionName (str), count, unit (str), function, arguments) to report per something else e.g. "item"
 using namespace std;
 template <typename Function, typename... Args>
 auto benchmark(Function fn, Args &&...args)
@@ -28,4 +39,178 @@ auto report_time(const string &fn_name, Function fn, Args &&...args)
     // Output time
     cout << "Time taken by " << fn_name << ": " << duration << " nanosecs\n";
     return duration;
+}
+
+// Linux perf_event_open counters for a region of code, counters that can't be opened are skipped
+// e.g. on other platforms, in VMs without a PMU or when perf_event_paranoid is too strict
+class PerfCounters
+{
+public:
+    static constexpr int numEvents = 7;
+
+private:
+    int fds[numEvents];
+    uint64_t values[numEvents] = {};
+
+#ifdef __linux__
+    static int openCounter(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        // Only count this process in user space so it works without extra permissions
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    static uint64_t cacheMiss(uint64_t cache)
+    {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+public:
+    PerfCounters()
+    {
+        for (int &fd : fds)
+        {
+            fd = -1;
+        }
+#ifdef __linux__
+        fds[0] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[1] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[2] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D));
+        fds[3] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL));
+        fds[4] = openCounter(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB));
+        fds[5] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds[6] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+    }
+    // Don't allow copying, the file descriptors are owned
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    static const char *name(int event)
+    {
+        static const char *names[numEvents] = {
+            "cycles", "instructions", "L1D misses", "LLC misses", "dTLB misses", "branch misses", "page faults"};
+        return names[event];
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop()
+    {
+#ifdef __linux__
+        for (int i = 0; i < numEvents; ++i)
+        {
+            values[i] = 0;
+            if (fds[i] < 0)
+            {
+                continue;
+            }
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            // value, time enabled, time running
+            uint64_t data[3] = {};
+            if (read(fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0)
+            {
+                // Scale up if the kernel had to share the hardware counters with other events
+                values[i] = data[2] < data[1] ? static_cast<uint64_t>(double(data[0]) * data[1] / data[2]) : data[0];
+            }
+        }
+#endif
+    }
+
+    bool has(int event) const
+    {
+        return fds[event] >= 0;
+    }
+    // True if at least one counter could be opened
+    bool available() const
+    {
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    uint64_t value(int event) const
+    {
+        return values[event];
+    }
+};
+
+template <typename Function, typename... Args>
+auto report_counters(const string &fn_name, size_t count, const char *unit, Function fn, Args &&...args)
+{
+    PerfCounters counters;
+    counters.start();
+    auto duration = benchmark(fn, forward<Args>(args)...);
+    counters.stop();
+
+    cout << "Time taken by " << fn_name << ": " << duration << " nanosecs";
+    if (count > 0)
+    {
+        cout << " (" << double(duration) / count << " per " << unit << ")";
+    }
+    cout << "\n";
+    if (!counters.available())
+    {
+        cout << "  Hardware counters unavailable, only reporting time\n";
+        return duration;
+    }
+    for (int i = 0; i < PerfCounters::numEvents; ++i)
+    {
+        cout << "  " << PerfCounters::name(i) << ": ";
+        if (!counters.has(i))
+        {
+            cout << "n/a\n";
+            continue;
+        }
+        cout << counters.value(i);
+        if (count > 0)
+        {
+            cout << " (" << double(counters.value(i)) / count << " per " << unit << ")";
+        }
+        cout << "\n";
+    }
+    return duration;
+}
+
+// Counts are per allocation unless a unit is given
+template <typename Function, typename... Args>
+auto report_counters(const string &fn_name, size_t allocations, Function fn, Args &&...args)
+{
+    return report_counters(fn_name, allocations, "allocation", fn, forward<Args>(args)...);
 }
\ No newline at end of file
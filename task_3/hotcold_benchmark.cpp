@@ -0,0 +1,107 @@
+#include "BumpUp.hpp"
+#include "HotColdArena.hpp"
+#include "benchmark.hpp"
+#include <cstdio>
+using namespace std;
+
+// Items which are walked every iteration each have metadata which is written once and rarely read.
+// Allocated together in a BumpUp the metadata sits between the items, in a HotColdArena it is kept in the cold region
+// so the items are packed together and the walk touches far fewer cache lines and pages.
+
+constexpr size_t arenaSize = 256 * 1024 * 1024;
+constexpr int numItems = 1000000;
+constexpr int numPasses = 20;
+
+struct Metadata
+{
+    // Never walked so keep it out of the way
+    using temperature = Cold;
+    char name[64];
+    long long created;
+    long long updated;
+    char owner[24];
+};
+
+struct Item
+{
+    Item *next;
+    long long value;
+    Metadata *meta;
+};
+
+// Interleaves item and metadata allocations the way request handling code would
+template <typename Arena>
+Item *buildList(Arena &arena)
+{
+    Item *head = nullptr;
+    Item **tail = &head;
+    for (int i = 0; i < numItems; ++i)
+    {
+        Item *item = arena.template alloc<Item>();
+        Metadata *meta = arena.template alloc<Metadata>();
+        if (item == nullptr || meta == nullptr)
+        {
+            return nullptr;
+        }
+        snprintf(meta->name, sizeof(meta->name), "item number %d", i);
+        snprintf(meta->owner, sizeof(meta->owner), "owner %d", i % 100);
+        meta->created = meta->updated = i;
+        *item = Item{nullptr, i % 1000, meta};
+        *tail = item;
+        tail = &item->next;
+    }
+    return head;
+}
+
+// Walks every item and only looks at the metadata of a few of them
+long long traverse(const Item *head)
+{
+    long long sum = 0;
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+        int index = 0;
+        for (const Item *item = head; item != nullptr; item = item->next, ++index)
+        {
+            sum += item->value;
+            if (index % 4096 == 0)
+            {
+                sum += item->meta->created;
+            }
+        }
+    }
+    return sum;
+}
+
+int main()
+{
+    auto *mixed = new BumpUp<arenaSize>;
+    auto *split = new HotColdArena<arenaSize>;
+
+    Item *mixedHead = buildList(*mixed);
+    Item *splitHead = buildList(*split);
+    if (mixedHead == nullptr || splitHead == nullptr)
+    {
+        cout << "Arena too small" << endl;
+        return 1;
+    }
+
+    RegionStats hot = split->getStats(Hot());
+    RegionStats cold = split->getStats(Cold());
+    cout << "BumpUp: " << mixed->getPtrPosition() << " bytes in " << mixed->getAllocCount() << " allocations" << endl;
+    cout << "HotColdArena hot region: " << hot.bytes_used << " bytes in " << hot.alloc_count << " allocations" << endl;
+    cout << "HotColdArena cold region: " << cold.bytes_used << " bytes in " << cold.alloc_count << " allocations" << endl;
+
+    long long mixedResult = 0, splitResult = 0;
+    size_t itemsWalked = size_t(numItems) * numPasses;
+    report_counters("mixed traversal (BumpUp)", itemsWalked, "item", [&]()
+                    { mixedResult = traverse(mixedHead); });
+    report_counters("segregated traversal (HotColdArena)", itemsWalked, "item", [&]()
+                    { splitResult = traverse(splitHead); });
+    cout << "Results match: " << (mixedResult == splitResult ? "yes" : "no") << endl;
+
+    delete mixed;
+    delete split;
+    return 0;
+}
+
+// clang++ -std=c++17 -O2 hotcold_benchmark.cpp
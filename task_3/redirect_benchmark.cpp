@@ -0,0 +1,126 @@
+#include "ArenaRedirect.hpp"
+#include "benchmark.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+// A legacy style parser which news everything and can't be given an allocator,
+// timed with the system allocator and with its allocations redirected to a BumpDown arena
+
+constexpr size_t arenaSize = 16 * 1024 * 1024;
+constexpr int numIterations = 200;
+
+struct Setting
+{
+    string section;
+    string key;
+    vector<string> values;
+};
+
+// Parses lines like "section.key = value, value, value" into heap allocated settings
+long long legacyParse(const string &text)
+{
+    vector<unique_ptr<Setting>> settings;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t lineEnd = text.find('\n', pos);
+        if (lineEnd == string::npos)
+        {
+            lineEnd = text.size();
+        }
+        string line = text.substr(pos, lineEnd - pos);
+        pos = lineEnd + 1;
+
+        size_t dot = line.find('.');
+        size_t equals = line.find('=');
+        if (dot == string::npos || equals == string::npos)
+        {
+            continue;
+        }
+        unique_ptr<Setting> setting(new Setting);
+        setting->section = line.substr(0, dot);
+        setting->key = line.substr(dot + 1, equals - dot - 2);
+        size_t start = equals + 2;
+        while (start < line.size())
+        {
+            size_t comma = line.find(',', start);
+            if (comma == string::npos)
+            {
+                comma = line.size();
+            }
+            setting->values.push_back(line.substr(start, comma - start));
+            start = comma + 2;
+        }
+        settings.push_back(move(setting));
+    }
+
+    long long checksum = 0;
+    for (const auto &setting : settings)
+    {
+        checksum += setting->section.size() + setting->key.size();
+        for (const string &value : setting->values)
+        {
+            checksum += value.size();
+        }
+    }
+    return checksum;
+}
+
+string generateConfig(int numLines)
+{
+    string text;
+    for (int i = 0; i < numLines; ++i)
+    {
+        text += "subsystem_section_" + to_string(i % 37) + ".configuration_key_" + to_string(i) + " = ";
+        for (int v = 0; v <= i % 6; ++v)
+        {
+            text += (v ? ", " : "") + string("some_longer_value_") + to_string(i * v);
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+int main()
+{
+    string config = generateConfig(5000);
+    // Created outside any scope so it comes from the system allocator
+    auto *arena = new BumpDown<arenaSize>;
+    long long systemResult = 0, arenaResult = 0;
+    int redirectedAllocs = 0;
+    size_t arenaUsed = 0;
+
+    int numRuns = 5;
+    for (int run = 0; run < numRuns; ++run)
+    {
+        report_time("legacy parse with system allocator", [&]()
+                    {
+                        for (int i = 0; i < numIterations; ++i)
+                        {
+                            systemResult += legacyParse(config);
+                        } });
+        report_time("legacy parse redirected to BumpDown", [&]()
+                    {
+                        for (int i = 0; i < numIterations; ++i)
+                        {
+                            {
+                                ScopedArenaRedirect redirect(*arena);
+                                arenaResult += legacyParse(config);
+                            }
+                            redirectedAllocs = arena->getAllocCount();
+                            arenaUsed = arenaSize - arena->getPtrPosition();
+                            arena->reset();
+                        } });
+    }
+    cout << "Results match: " << (systemResult == arenaResult ? "yes" : "no") << ", allocations redirected per parse: "
+         << redirectedAllocs << ", arena bytes used per parse: " << arenaUsed << endl;
+
+    // Nothing allocated in the arena is left so it can stop being treated as arena memory
+    unregisterArenaRedirect(*arena);
+    delete arena;
+    return 0;
+}
+
+// clang++ -std=c++17 -O2 redirect_benchmark.cpp ArenaRedirect.cpp
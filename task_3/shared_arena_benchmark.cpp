@@ -0,0 +1,223 @@
+#include "SharedArena.hpp"
+#include "benchmark.hpp"
+#include <array>
+#include <deque>
+#include <thread>
+using namespace std;
+
+// Producer threads build messages and consumer threads read and free them.
+// Compares a new/delete per message against SharedArena where freeing a message is one atomic decrement.
+
+constexpr size_t arenaSize = 256 * 1024;
+constexpr int numProducers = 4;
+constexpr int numConsumers = 4;
+constexpr int messagesPerProducer = 500000;
+constexpr int batchSize = 32;
+
+struct Message
+{
+    int length;
+    int *payload;
+};
+
+// Message plus the arena that owns it, the arena handle is empty for new/delete messages
+struct Envelope
+{
+    SharedArena<arenaSize> arena;
+    Message *message = nullptr;
+};
+
+struct Batch
+{
+    array<Envelope, batchSize> envelopes;
+    int count = 0;
+};
+
+// Same queue for both versions, messages are pushed in batches to keep the locking cost down
+class BatchQueue
+{
+private:
+    deque<Batch> batches;
+    mutex lock;
+    condition_variable ready;
+    int producersLeft;
+
+public:
+    explicit BatchQueue(int producers) : producersLeft(producers) {}
+
+    void push(Batch &&batch)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            batches.push_back(move(batch));
+        }
+        ready.notify_one();
+    }
+    void producerDone()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            producersLeft--;
+        }
+        ready.notify_all();
+    }
+    // Returns false when every producer has finished and the queue is empty
+    bool pop(Batch &batch)
+    {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [this]()
+                   { return !batches.empty() || producersLeft == 0; });
+        if (batches.empty())
+        {
+            return false;
+        }
+        batch = move(batches.front());
+        batches.pop_front();
+        return true;
+    }
+};
+
+int messageLength(int i)
+{
+    return 4 + (i * 7) % 60;
+}
+
+void fillPayload(Message *message, int i)
+{
+    for (int j = 0; j < message->length; ++j)
+    {
+        message->payload[j] = i + j;
+    }
+}
+
+void produceNewDelete(BatchQueue &queue)
+{
+    Batch batch;
+    for (int i = 0; i < messagesPerProducer; ++i)
+    {
+        Message *message = new Message{messageLength(i), nullptr};
+        message->payload = new int[message->length];
+        fillPayload(message, i);
+        batch.envelopes[batch.count++].message = message;
+        if (batch.count == batchSize)
+        {
+            queue.push(move(batch));
+            batch = Batch();
+        }
+    }
+    if (batch.count > 0)
+    {
+        queue.push(move(batch));
+    }
+    queue.producerDone();
+}
+
+void produceArena(BatchQueue &queue, ArenaPool<arenaSize> &pool)
+{
+    Batch batch;
+    SharedArena<arenaSize> current = pool.acquire();
+    for (int i = 0; i < messagesPerProducer; ++i)
+    {
+        int length = messageLength(i);
+        Message *message = current.alloc<Message>();
+        int *payload = message ? current.alloc<int>(length) : nullptr;
+        if (payload == nullptr)
+        {
+            // Arena is full, drop our reference so it goes back to the pool once consumers are done with it
+            current = SharedArena<arenaSize>();
+            current = pool.acquire();
+            message = current.alloc<Message>();
+            payload = current.alloc<int>(length);
+        }
+        message->length = length;
+        message->payload = payload;
+        fillPayload(message, i);
+        batch.envelopes[batch.count].arena = current;
+        batch.envelopes[batch.count++].message = message;
+        if (batch.count == batchSize)
+        {
+            queue.push(move(batch));
+            batch = Batch();
+        }
+    }
+    if (batch.count > 0)
+    {
+        queue.push(move(batch));
+    }
+    queue.producerDone();
+}
+
+void consume(BatchQueue &queue, atomic<long long> &total, bool useDelete)
+{
+    Batch batch;
+    long long sum = 0;
+    while (queue.pop(batch))
+    {
+        for (int i = 0; i < batch.count; ++i)
+        {
+            Message *message = batch.envelopes[i].message;
+            for (int j = 0; j < message->length; ++j)
+            {
+                sum += message->payload[j];
+            }
+            if (useDelete)
+            {
+                delete[] message->payload;
+                delete message;
+            }
+            // Dropping the handle is the only cost of freeing an arena message
+            batch.envelopes[i] = Envelope();
+        }
+    }
+    total += sum;
+}
+
+long long runPipeline(bool useArena, ArenaPool<arenaSize> &pool)
+{
+    BatchQueue queue(numProducers);
+    atomic<long long> total{0};
+    vector<thread> threads;
+    for (int i = 0; i < numProducers; ++i)
+    {
+        if (useArena)
+        {
+            threads.emplace_back(produceArena, ref(queue), ref(pool));
+        }
+        else
+        {
+            threads.emplace_back(produceNewDelete, ref(queue));
+        }
+    }
+    for (int i = 0; i < numConsumers; ++i)
+    {
+        threads.emplace_back(consume, ref(queue), ref(total), !useArena);
+    }
+    for (thread &t : threads)
+    {
+        t.join();
+    }
+    return total;
+}
+
+int main()
+{
+    // Enough arenas for every producer to hold one while consumers are still reading older ones
+    ArenaPool<arenaSize> pool(numProducers * 8);
+    long long newDeleteResult = 0, arenaResult = 0;
+
+    cout << numProducers << " producers, " << numConsumers << " consumers, "
+         << numProducers * messagesPerProducer << " messages" << endl;
+    int numRuns = 5;
+    for (int i = 0; i < numRuns; ++i)
+    {
+        report_time("new/delete pipeline", [&]()
+                    { newDeleteResult = runPipeline(false, pool); });
+        report_time("SharedArena pipeline", [&]()
+                    { arenaResult = runPipeline(true, pool); });
+    }
+    cout << "Results match: " << (newDeleteResult == arenaResult ? "yes" : "no")
+         << ", arenas back in pool: " << pool.available() << endl;
+    return 0;
+}
+
+// clang++ -std=c++17 -O2 -pthread shared_arena_benchmark.cpp
@@ -0,0 +1,135 @@
+#include "BumpUp.hpp"
+#include "Snapshot.hpp"
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+using namespace std;
+
+// Compares building a read only lookup table from scratch against mapping a snapshot of it back in.
+// The table only stores offsets from the start of the arena so it works wherever the snapshot is mapped.
+
+constexpr size_t arenaSize = 64 * 1024 * 1024;
+constexpr uint64_t numEntries = 1000000;
+const char *snapshotPath = "lookup_table.snap";
+
+struct LookupTable
+{
+    uint64_t count;
+    uint64_t entries; // offset of the first Entry
+};
+
+struct Entry
+{
+    uint64_t key;
+    uint32_t name_offset;
+    uint32_t name_length;
+};
+
+// Mix the bits so keys arrive out of order and the sort has work to do
+uint64_t makeKey(uint64_t i)
+{
+    i ^= i >> 33;
+    i *= 0xff51afd7ed558ccdULL;
+    i ^= i >> 33;
+    return i;
+}
+
+void buildTable(BumpUp<arenaSize> &arena)
+{
+    // Table header goes first so it is always at offset 0
+    LookupTable *table = arena.alloc<LookupTable>();
+    Entry *entries = arena.alloc<Entry>(numEntries);
+    const char *base = arena.getHeap();
+    table->count = numEntries;
+    table->entries = reinterpret_cast<const char *>(entries) - base;
+
+    for (uint64_t i = 0; i < numEntries; ++i)
+    {
+        string name = "item_" + to_string(i);
+        char *stored = arena.alloc<char>(name.size());
+        memcpy(stored, name.data(), name.size());
+        entries[i] = {makeKey(i), static_cast<uint32_t>(stored - base), static_cast<uint32_t>(name.size())};
+    }
+    sort(entries, entries + numEntries, [](const Entry &a, const Entry &b)
+         { return a.key < b.key; });
+}
+
+// Binary search the table, base is wherever the arena or snapshot currently lives
+string lookup(const char *base, uint64_t key)
+{
+    const LookupTable *table = reinterpret_cast<const LookupTable *>(base);
+    const Entry *first = reinterpret_cast<const Entry *>(base + table->entries);
+    const Entry *last = first + table->count;
+    const Entry *found = lower_bound(first, last, key, [](const Entry &e, uint64_t k)
+                                     { return e.key < k; });
+    if (found == last || found->key != key)
+    {
+        return "";
+    }
+    return string(base + found->name_offset, found->name_length);
+}
+
+bool checkLookups(const char *base)
+{
+    for (uint64_t i = 0; i < numEntries; i += 997)
+    {
+        if (lookup(base, makeKey(i)) != "item_" + to_string(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Times mapping the snapshot plus the first lookups, returns false if it couldn't be mapped
+bool timeSnapshotLoad(const char *label, long long buildTime)
+{
+    MappedSnapshot snapshot;
+    bool opened = false;
+    auto loadTime = report_time(label, [&]()
+                                {
+                                    opened = snapshot.open(snapshotPath);
+                                    // First lookups are part of the load as they fault the pages in
+                                    if (opened)
+                                    {
+                                        checkLookups(snapshot.data());
+                                    } });
+    if (!opened)
+    {
+        cout << "Failed to map snapshot" << endl;
+        return false;
+    }
+    cout << "Mapped at original address: " << (snapshot.atOriginalAddress() ? "yes" : "no")
+         << ", lookups match: " << (checkLookups(snapshot.data()) ? "yes" : "no")
+         << ", speedup over cold build: " << double(buildTime) / loadTime << "x" << endl;
+    return true;
+}
+
+int main()
+{
+    // Allocate arena on the heap as it is too large for the stack
+    BumpUp<arenaSize> *arena = new BumpUp<arenaSize>;
+
+    auto buildTime = report_time("cold build", buildTable, *arena);
+    cout << "Arena used: " << arena->getPtrPosition() << " bytes in " << arena->getAllocCount() << " allocations" << endl;
+
+    if (!saveSnapshot(*arena, snapshotPath))
+    {
+        cout << "Failed to write snapshot" << endl;
+        return 1;
+    }
+
+    // The arena is still alive so its address is taken and the snapshot is mapped somewhere else
+    bool loaded = timeSnapshotLoad("snapshot load (arena alive)", buildTime);
+
+    delete arena;
+
+    // Arena memory has been returned so the original address may be free again, like a restarted process
+    loaded = loaded && timeSnapshotLoad("snapshot load (arena freed)", buildTime);
+
+    remove(snapshotPath);
+    return loaded ? 0 : 1;
+}
+
+// clang++ -std=c++17 -O2 snapshot_benchmark.cpp
@@ -0,0 +1,684 @@
+#include "BumpUp.hpp"
+#include "BumpDown.hpp"
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <vector>
+using namespace std;
+
+// Realistic allocation patterns rather than the unit tests: parsing a JSON DOM, BFS over a graph
+// and tokenizing and interning strings. Every workload is a template on the allocator and is run
+// against BumpUp, BumpDown, malloc and std::pmr::monotonic_buffer_resource.
+// Each run happens in a forked child. The child starts with the inputs already resident, so the RSS reported is
+// the child's peak minus its RSS when it started, which is what the allocator and workload added.
+
+constexpr size_t arenaSize = 512 * 1024 * 1024;
+constexpr int numIterations = 3;
+
+// Allocators all need alloc<T>(N) which returns nullptr on failure and reset() to free everything
+// BumpUp and BumpDown already have these, malloc and pmr need a wrapper
+
+// Calls malloc for every allocation and frees them all on reset
+class MallocArena
+{
+private:
+    vector<void *> allocations;
+
+public:
+    MallocArena() = default;
+    MallocArena &operator=(const MallocArena &) = delete;
+    ~MallocArena()
+    {
+        reset();
+    }
+    template <typename T>
+    T *alloc(size_t N = 1)
+    {
+        void *result = malloc(N * sizeof(T));
+        if (result != nullptr)
+        {
+            allocations.push_back(result);
+        }
+        return static_cast<T *>(result);
+    }
+    void reset()
+    {
+        for (void *allocation : allocations)
+        {
+            free(allocation);
+        }
+        allocations.clear();
+    }
+};
+
+class PmrArena
+{
+private:
+    pmr::monotonic_buffer_resource resource;
+
+public:
+    PmrArena() = default;
+    PmrArena &operator=(const PmrArena &) = delete;
+    template <typename T>
+    T *alloc(size_t N = 1)
+    {
+        try
+        {
+            return static_cast<T *>(resource.allocate(N * sizeof(T), alignof(T)));
+        }
+        catch (const bad_alloc &)
+        {
+            return nullptr;
+        }
+    }
+    void reset()
+    {
+        resource.release();
+    }
+};
+
+// JSON DOM
+
+struct JsonValue
+{
+    enum Kind : uint8_t
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    } kind;
+    uint32_t keyLength;
+    uint32_t length; // string length or number of children
+    const char *key; // member name when inside an object
+    const char *str;
+    double number;
+    JsonValue *child;
+    JsonValue *next;
+};
+
+// Array of records with nested arrays and objects, like a typical API response
+string generateJson(int numRecords)
+{
+    mt19937 rng(1);
+    string json = "[";
+    for (int i = 0; i < numRecords; ++i)
+    {
+        json += i ? ",\n" : "\n";
+        json += "{\"id\":" + to_string(i) + ",\"name\":\"user_" + to_string(rng() % 100000) +
+                "\",\"active\":" + (rng() % 2 ? "true" : "false") + ",\"score\":" + to_string(rng() % 1000) +
+                ".5,\"tags\":[";
+        int numTags = rng() % 5;
+        for (int t = 0; t < numTags; ++t)
+        {
+            json += (t ? ",\"tag" : "\"tag") + to_string(rng() % 50) + "\"";
+        }
+        json += "],\"address\":{\"street\":\"" + to_string(rng() % 999) + " Main St\",\"zip\":" +
+                to_string(rng() % 99999) + ",\"extra\":null}}";
+    }
+    json += "\n]";
+    return json;
+}
+
+template <typename Arena>
+class JsonParser
+{
+private:
+    Arena &arena;
+    const char *p;
+    const char *end;
+    uint64_t nodes = 0;
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r'))
+        {
+            p++;
+        }
+    }
+
+    // Copies the string into the arena, escapes are kept as they are
+    const char *parseString(uint32_t &length)
+    {
+        const char *start = ++p;
+        while (p < end && *p != '"')
+        {
+            p += (*p == '\\') ? 2 : 1;
+        }
+        length = static_cast<uint32_t>(p - start);
+        p++;
+        char *copy = arena.template alloc<char>(length);
+        if (copy != nullptr)
+        {
+            memcpy(copy, start, length);
+        }
+        return copy;
+    }
+
+public:
+    JsonParser(Arena &arena, const string &text) : arena(arena), p(text.data()), end(text.data() + text.size()) {}
+
+    uint64_t getNodeCount() const
+    {
+        return nodes;
+    }
+
+    // Returns nullptr if the arena runs out or the input is malformed
+    JsonValue *parseValue()
+    {
+        skipSpace();
+        JsonValue *value = arena.template alloc<JsonValue>();
+        if (value == nullptr || p >= end)
+        {
+            return nullptr;
+        }
+        *value = JsonValue{JsonValue::Null, 0, 0, nullptr, nullptr, 0.0, nullptr, nullptr};
+        nodes++;
+        if (*p == '{' || *p == '[')
+        {
+            bool isObject = *p == '{';
+            value->kind = isObject ? JsonValue::Object : JsonValue::Array;
+            char close = isObject ? '}' : ']';
+            p++;
+            JsonValue **tail = &value->child;
+            skipSpace();
+            while (p < end && *p != close)
+            {
+                const char *key = nullptr;
+                uint32_t keyLength = 0;
+                if (isObject)
+                {
+                    key = parseString(keyLength);
+                    skipSpace();
+                    p++; // ':'
+                }
+                JsonValue *item = parseValue();
+                if (item == nullptr || (isObject && key == nullptr))
+                {
+                    return nullptr;
+                }
+                item->key = key;
+                item->keyLength = keyLength;
+                *tail = item;
+                tail = &item->next;
+                value->length++;
+                skipSpace();
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    skipSpace();
+                }
+            }
+            p++;
+        }
+        else if (*p == '"')
+        {
+            value->kind = JsonValue::String;
+            value->str = parseString(value->length);
+            if (value->str == nullptr && value->length > 0)
+            {
+                return nullptr;
+            }
+        }
+        else if (*p == 't' || *p == 'f')
+        {
+            value->kind = JsonValue::Bool;
+            value->number = *p == 't';
+            p += *p == 't' ? 4 : 5;
+        }
+        else if (*p == 'n')
+        {
+            p += 4;
+        }
+        else
+        {
+            value->kind = JsonValue::Number;
+            char *numberEnd;
+            value->number = strtod(p, &numberEnd);
+            p = numberEnd;
+        }
+        return value;
+    }
+};
+
+uint64_t jsonChecksum(const JsonValue *value)
+{
+    uint64_t sum = value->kind + value->length + value->keyLength + static_cast<uint64_t>(value->number);
+    for (const JsonValue *child = value->child; child != nullptr; child = child->next)
+    {
+        sum += jsonChecksum(child);
+    }
+    return sum;
+}
+
+struct WorkloadResult
+{
+    bool ok;
+    uint64_t ops;
+    uint64_t checksum;
+};
+
+template <typename Arena>
+WorkloadResult jsonWorkload(Arena &arena, const string &json)
+{
+    WorkloadResult result{true, 0, 0};
+    for (int i = 0; i < numIterations; ++i)
+    {
+        JsonParser<Arena> parser(arena, json);
+        JsonValue *root = parser.parseValue();
+        if (root == nullptr)
+        {
+            return {false, 0, 0};
+        }
+        result.ops += parser.getNodeCount();
+        result.checksum += jsonChecksum(root);
+        arena.reset();
+    }
+    return result;
+}
+
+// Graph BFS
+
+// Compressed sparse row graph, built once outside the allocator being tested
+struct Graph
+{
+    vector<uint32_t> offsets;
+    vector<uint32_t> edges;
+};
+
+Graph generateGraph(uint32_t numVertices, uint32_t averageDegree)
+{
+    mt19937 rng(2);
+    Graph graph;
+    graph.offsets.resize(numVertices + 1);
+    for (uint32_t v = 0; v < numVertices; ++v)
+    {
+        graph.offsets[v] = static_cast<uint32_t>(graph.edges.size());
+        uint32_t degree = 1 + rng() % (averageDegree * 2);
+        for (uint32_t e = 0; e < degree; ++e)
+        {
+            graph.edges.push_back(rng() % numVertices);
+        }
+    }
+    graph.offsets[numVertices] = static_cast<uint32_t>(graph.edges.size());
+    return graph;
+}
+
+// Every level allocates a new frontier buffer sized for the worst case, the arena is reset after each search
+template <typename Arena>
+WorkloadResult bfsWorkload(Arena &arena, const Graph &graph)
+{
+    constexpr int numSources = 8;
+    uint32_t numVertices = static_cast<uint32_t>(graph.offsets.size() - 1);
+    WorkloadResult result{true, 0, 0};
+    for (int i = 0; i < numIterations; ++i)
+    {
+        for (int source = 0; source < numSources; ++source)
+        {
+            uint8_t *visited = arena.template alloc<uint8_t>(numVertices);
+            uint32_t *frontier = arena.template alloc<uint32_t>(1);
+            if (visited == nullptr || frontier == nullptr)
+            {
+                return {false, 0, 0};
+            }
+            memset(visited, 0, numVertices);
+            uint32_t start = static_cast<uint32_t>(source) * (numVertices / numSources);
+            frontier[0] = start;
+            visited[start] = 1;
+            size_t frontierSize = 1;
+            uint64_t level = 0;
+            while (frontierSize > 0)
+            {
+                size_t bound = 0;
+                for (size_t f = 0; f < frontierSize; ++f)
+                {
+                    bound += graph.offsets[frontier[f] + 1] - graph.offsets[frontier[f]];
+                }
+                uint32_t *nextFrontier = arena.template alloc<uint32_t>(bound);
+                if (nextFrontier == nullptr && bound > 0)
+                {
+                    return {false, 0, 0};
+                }
+                size_t nextSize = 0;
+                for (size_t f = 0; f < frontierSize; ++f)
+                {
+                    uint32_t v = frontier[f];
+                    for (uint32_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e)
+                    {
+                        uint32_t w = graph.edges[e];
+                        if (!visited[w])
+                        {
+                            visited[w] = 1;
+                            nextFrontier[nextSize++] = w;
+                        }
+                    }
+                }
+                result.ops += bound;
+                result.checksum += ++level * nextSize;
+                frontier = nextFrontier;
+                frontierSize = nextSize;
+            }
+            arena.reset();
+        }
+    }
+    return result;
+}
+
+// Tokenizing and interning
+
+// Words from a fixed vocabulary, with some much more common than others
+string generateText(int numWords, int vocabularySize)
+{
+    mt19937 rng(3);
+    vector<string> vocabulary(vocabularySize);
+    for (string &word : vocabulary)
+    {
+        int length = 3 + rng() % 8;
+        for (int c = 0; c < length; ++c)
+        {
+            word += static_cast<char>('a' + rng() % 26);
+        }
+    }
+    string text;
+    for (int i = 0; i < numWords; ++i)
+    {
+        // Multiplying two random numbers skews towards the start of the vocabulary
+        uint64_t index = (uint64_t(rng() % vocabularySize) * (rng() % vocabularySize)) / vocabularySize;
+        text += vocabulary[index];
+        text += (i % 17 == 16) ? ".\n" : " ";
+    }
+    return text;
+}
+
+struct Token
+{
+    uint32_t id;
+    uint32_t offset;
+};
+
+struct TokenChunk
+{
+    static constexpr int capacity = 4096;
+    TokenChunk *next;
+    int count;
+    Token tokens[capacity];
+};
+
+// Open addressing table, all of the strings and tables live in the arena and old tables are abandoned on growth
+template <typename Arena>
+class Interner
+{
+private:
+    struct Slot
+    {
+        const char *str;
+        uint32_t length;
+        uint32_t id;
+    };
+    Arena &arena;
+    Slot *slots = nullptr;
+    size_t capacity = 0;
+    uint32_t count = 0;
+
+    static uint64_t hash(const char *str, size_t length)
+    {
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < length; ++i)
+        {
+            h = (h ^ static_cast<uint8_t>(str[i])) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+    bool grow()
+    {
+        size_t newCapacity = capacity ? capacity * 2 : 1024;
+        Slot *newSlots = arena.template alloc<Slot>(newCapacity);
+        if (newSlots == nullptr)
+        {
+            return false;
+        }
+        memset(newSlots, 0, newCapacity * sizeof(Slot));
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            if (slots[i].str != nullptr)
+            {
+                size_t index = hash(slots[i].str, slots[i].length) & (newCapacity - 1);
+                while (newSlots[index].str != nullptr)
+                {
+                    index = (index + 1) & (newCapacity - 1);
+                }
+                newSlots[index] = slots[i];
+            }
+        }
+        slots = newSlots;
+        capacity = newCapacity;
+        return true;
+    }
+
+public:
+    explicit Interner(Arena &arena) : arena(arena) {}
+
+    // Returns UINT32_MAX if the arena runs out
+    uint32_t intern(const char *str, uint32_t length)
+    {
+        if ((count + 1) * 10 > capacity * 7 && !grow())
+        {
+            return UINT32_MAX;
+        }
+        size_t index = hash(str, length) & (capacity - 1);
+        while (slots[index].str != nullptr)
+        {
+            if (slots[index].length == length && memcmp(slots[index].str, str, length) == 0)
+            {
+                return slots[index].id;
+            }
+            index = (index + 1) & (capacity - 1);
+        }
+        char *copy = arena.template alloc<char>(length);
+        if (copy == nullptr)
+        {
+            return UINT32_MAX;
+        }
+        memcpy(copy, str, length);
+        slots[index] = {copy, length, count};
+        return count++;
+    }
+};
+
+template <typename Arena>
+WorkloadResult tokenizeWorkload(Arena &arena, const string &text)
+{
+    WorkloadResult result{true, 0, 0};
+    for (int i = 0; i < numIterations; ++i)
+    {
+        Interner<Arena> interner(arena);
+        TokenChunk *head = nullptr;
+        TokenChunk *tail = nullptr;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            while (pos < text.size() && !isalpha(static_cast<unsigned char>(text[pos])))
+            {
+                pos++;
+            }
+            size_t start = pos;
+            while (pos < text.size() && isalpha(static_cast<unsigned char>(text[pos])))
+            {
+                pos++;
+            }
+            if (pos == start)
+            {
+                break;
+            }
+            uint32_t id = interner.intern(text.data() + start, static_cast<uint32_t>(pos - start));
+            if (tail == nullptr || tail->count == TokenChunk::capacity)
+            {
+                TokenChunk *chunk = arena.template alloc<TokenChunk>();
+                if (chunk == nullptr)
+                {
+                    return {false, 0, 0};
+                }
+                chunk->next = nullptr;
+                chunk->count = 0;
+                (tail ? tail->next : head) = chunk;
+                tail = chunk;
+            }
+            if (id == UINT32_MAX)
+            {
+                return {false, 0, 0};
+            }
+            tail->tokens[tail->count++] = {id, static_cast<uint32_t>(start)};
+            result.ops++;
+        }
+        for (TokenChunk *chunk = head; chunk != nullptr; chunk = chunk->next)
+        {
+            for (int t = 0; t < chunk->count; ++t)
+            {
+                result.checksum += chunk->tokens[t].id;
+            }
+        }
+        arena.reset();
+    }
+    return result;
+}
+
+// Harness
+
+struct RunResult
+{
+    WorkloadResult workload;
+    long long nanoseconds;
+    long startRssKb;
+};
+
+// Resident memory of this process right now in KB, 0 if it can't be read
+long currentRssKb()
+{
+    long totalPages = 0, residentPages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr)
+    {
+        return 0;
+    }
+    if (fscanf(statm, "%ld %ld", &totalPages, &residentPages) != 2)
+    {
+        residentPages = 0;
+    }
+    fclose(statm);
+    return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Runs the workload in a child process and reports throughput and how far the child's peak RSS rose while running
+template <typename Workload>
+void runIsolated(const char *workloadName, const char *allocatorName, Workload workload)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        cout << "Failed to create pipe" << endl;
+        return;
+    }
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        cout << "  " << workloadName << " / " << allocatorName << ": failed to fork" << endl;
+        return;
+    }
+    if (child == 0)
+    {
+        close(fds[0]);
+        RunResult result;
+        // Pages the parent freed while generating inputs are still resident, without this malloc would reuse them
+        // and its RSS would barely grow while the arenas have to fault in fresh pages
+        malloc_trim(0);
+        // Measured in the child as it doesn't share every resident page of the parent
+        result.startRssKb = currentRssKb();
+        result.nanoseconds = benchmark([&]()
+                                       { result.workload = workload(); });
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    RunResult result{};
+    bool received = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+    struct rusage usage{};
+    int status = 0;
+    wait4(child, &status, 0, &usage);
+
+    cout << "  " << workloadName << " / " << allocatorName << ": ";
+    if (WIFSIGNALED(status))
+    {
+        cout << "failed (child killed by signal " << WTERMSIG(status) << ")" << endl;
+        return;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !received)
+    {
+        cout << "failed (child didn't report a result)" << endl;
+        return;
+    }
+    if (!result.workload.ok)
+    {
+        cout << "failed (allocator ran out of memory)" << endl;
+        return;
+    }
+    double seconds = result.nanoseconds / 1e9;
+    cout << result.workload.ops / seconds / 1e6 << " M ops/sec, "
+         << "peak RSS above inputs " << max(0L, usage.ru_maxrss - result.startRssKb) / 1024.0 << " MB, checksum "
+         << result.workload.checksum << endl;
+}
+
+// Creates the allocator inside the child so its memory only counts against that run
+template <typename Arena, typename Workload>
+void runWithArena(const char *workloadName, const char *allocatorName, Workload workload)
+{
+    runIsolated(workloadName, allocatorName, [&]()
+                {
+                    unique_ptr<Arena> arena(new Arena);
+                    return workload(*arena); });
+}
+
+template <typename Workload>
+void runAllAllocators(const char *workloadName, Workload workload)
+{
+    cout << workloadName << endl;
+    runWithArena<BumpUp<arenaSize>>(workloadName, "BumpUp", workload);
+    runWithArena<BumpDown<arenaSize>>(workloadName, "BumpDown", workload);
+    runWithArena<MallocArena>(workloadName, "malloc", workload);
+    runWithArena<PmrArena>(workloadName, "pmr monotonic", workload);
+}
+
+int main()
+{
+    // Inputs are generated once before forking so every run shares them
+    string json = generateJson(200000);
+    Graph graph = generateGraph(1000000, 8);
+    string text = generateText(2000000, 50000);
+
+    cout << "RSS with inputs generated: " << currentRssKb() / 1024 << " MB, not included in the figures below" << endl;
+    cout << "Ops are JSON nodes, edges visited and tokens, checksums should match across allocators" << endl;
+
+    runAllAllocators("JSON DOM", [&](auto &arena)
+                     { return jsonWorkload(arena, json); });
+    runAllAllocators("Graph BFS", [&](auto &arena)
+                     { return bfsWorkload(arena, graph); });
+    runAllAllocators("Tokenize and intern", [&](auto &arena)
+                     { return tokenizeWorkload(arena, text); });
+    return 0;
+}
+
+// clang++ -std=c++17 -O2 workloads.cpp